@@ -2,9 +2,36 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <omp.h>
 
 #define M_PI 3.14159265358979323846 // Definición de PI
+#define SEMILLA 12345ULL // Semilla de la simulación, el mismo valor produce el mismo reporte en la versión secuencial y en la paralela
+#define TAM_BLOQUE_SUMA 4096 // Tamaño mínimo de los bloques de las sumas reproducibles, no depende del número de hilos
+#define MAX_BLOQUES_SUMA 1024 // Máximo de sumas parciales, se guardan en la pila; con más datos los bloques crecen en función de numDatos
+
+#ifndef MODO_REPRODUCIBLE
+#define MODO_REPRODUCIBLE 1 // 1: sumas por bloques fijos, idénticas bit a bit con cualquier número de hilos. 0: reduction(+) de OpenMP
+#endif
+#define MAX_VALORES_BLOQUE 1048576 // Máximo de rendimientos leídos a la vez del archivo de escenarios (8 MB)
+
+#define CORR_IDENTIDAD 0 // Activos independientes
+#define CORR_CHOLESKY 1 // Matriz de correlación general, se usa su factor de Cholesky
+#define CORR_FACTOR 2 // Todas las correlaciones iguales, se simula con un factor común
+
+#if defined(__GNUC__)
+#define SIEMPRE_EN_LINEA static inline __attribute__((always_inline)) // Obliga a expandir el cuerpo común dentro de cada núcleo
+#elif defined(_MSC_VER)
+#define SIEMPRE_EN_LINEA static __forceinline
+#else
+#define SIEMPRE_EN_LINEA static inline
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DESPACHO_ISA 1 // Se genera una copia de los núcleos con AVX2 y FMA, elegida al inicio si el procesador la soporta
+#else
+#define DESPACHO_ISA 0
+#endif
 
 // Estructura para almacenar los datos de un activo
 typedef struct {
@@ -51,28 +78,314 @@ int leerArchivoTXT(const char* nombreArchivo, Activo** cartera, int* numActivos)
 }
 
 
-// Función para generar un número aleatorio con distribución normal usando el método Box-Muller
-double generarDistribucionNormal(double media, double desviacion) { // Genera un número aleatorio con distribución normal
-    double u1 = (double)rand() / RAND_MAX; // Genera un número aleatorio entre 0 y 1, RAND_MAX es la máxima cantidad de números aleatorios que se pueden generar
-    double u2 = (double)rand() / RAND_MAX; // Genera otro número aleatorio entre 0 y 1
+// Función para generar un número aleatorio uniforme en (0, 1] con el algoritmo SplitMix64
+double generarUniforme(unsigned long long* estado) { // Cada escenario tiene su propio estado, así la secuencia no depende del hilo que lo simula (rand() es compartido entre hilos)
+    unsigned long long z = (*estado += 0x9E3779B97F4A7C15ULL); // Avanza el estado en una constante fija
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL; // Mezcla los bits del estado
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return ((z >> 11) + 1) * (1.0 / 9007199254740992.0); // Usa los 53 bits altos, nunca retorna 0 para que log(u1) sea válido
+}
+
+
+// Función para generar un número aleatorio con distribución normal estándar en precisión simple
+SIEMPRE_EN_LINEA float generarDistribucionNormalSimple(unsigned long long* estado) { // Igual que generarDistribucionNormalDoble, pero con logf, cosf y sqrtf
+    float u1 = (float)generarUniforme(estado);
+    float u2 = (float)generarUniforme(estado);
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+
+// Función para generar un número aleatorio con distribución normal estándar usando el método Box-Muller
+SIEMPRE_EN_LINEA double generarDistribucionNormalDoble(unsigned long long* estado) { // Se expande dentro de cada núcleo, la media 0 y la desviación 1 no se pasan como parámetros
+    double u1 = generarUniforme(estado); // Genera un número aleatorio entre 0 y 1
+    double u2 = generarUniforme(estado); // Genera otro número aleatorio entre 0 y 1
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2); // Calcula la parte real de un número complejo, usando la fórmula de Box-Muller
+} // El método Box-Muller convierte dos números uniformes entre 0 y 1 en un número con distribución normal estándar
+
+
+// Estructura con los parámetros de la cartera ya calculados para los núcleos de simulación
+typedef struct {
+    int numActivos;
+    int numPasos; // Número de pasos en que se divide el horizonte
+    double* valorActual; // Precio actual de cada activo
+    double* driftD; // (tasa - volatilidad^2 / 2) * dt de cada activo
+    double* volD; // volatilidad * raíz de dt de cada activo
+    double* choleskyD; // Factor de Cholesky de la matriz de correlación, triangular inferior guardada por columnas (numActivos * numActivos), así el núcleo recorre memoria contigua
+    double* cargaComunD; // Raíz de la correlación común, usada en el modelo de un factor
+    double* cargaPropiaD; // Raíz de (1 - correlación común), usada en el modelo de un factor
+    float* driftF; // Los mismos datos en precisión simple
+    float* volF;
+    float* choleskyF;
+    float* cargaComunF;
+    float* cargaPropiaF;
+} ParametrosNucleo;
+
+// Tipo de los núcleos: simulan un escenario, guardan el valor ajustado de cada activo en valores y retornan la pérdida
+// trabajo debe tener espacio para 3 * numActivos doubles
+typedef double (*FuncionNucleo)(const ParametrosNucleo* parametros, unsigned long long* estado, void* trabajo, double* valores);
+
+
+// Cuerpo común de los núcleos, se genera una vez por tipo de dato (double o float)
+// pasosMultiples y correlacion siempre se reciben como constantes, así al expandirse en cada núcleo el compilador elimina las ramas del ciclo interno
+// Los números aleatorios se generan en un ciclo aparte; los ciclos que actualizan x y el producto por el factor de Cholesky solo recorren arrays y se vectorizan (omp simd)
+#define DEFINIR_CUERPO_NUCLEO(TIPO, SUF, NORMAL, EXP) \
+SIEMPRE_EN_LINEA double cuerpoNucleo##SUF(const ParametrosNucleo* p, const int pasosMultiples, const int correlacion, unsigned long long* estado, void* trabajo, double* valores) { \
+    int n = p->numActivos; \
+    TIPO* z = (TIPO*)trabajo; /* Shocks independientes del paso */ \
+    TIPO* y = z + n; /* Shocks correlacionados del paso (solo Cholesky) */ \
+    TIPO* x = y + n; /* Logaritmo del rendimiento acumulado de cada activo */ \
+    const TIPO* drift = p->drift##SUF; \
+    const TIPO* vol = p->vol##SUF; \
+    int pasos = pasosMultiples ? p->numPasos : 1; \
+    for (int j = 0; j < n; j++) { \
+        x[j] = 0; \
+    } \
+    for (int k = 0; k < pasos; k++) { \
+        TIPO factor = (correlacion == CORR_FACTOR) ? NORMAL(estado) : 0; /* En el modelo de un factor, el factor común se genera antes que los shocks propios */ \
+        for (int j = 0; j < n; j++) { \
+            z[j] = NORMAL(estado); \
+        } \
+        if (correlacion == CORR_IDENTIDAD) { /* Activos independientes */ \
+            _Pragma("omp simd") \
+            for (int j = 0; j < n; j++) { \
+                x[j] += drift[j] + vol[j] * z[j]; \
+            } \
+        } else if (correlacion == CORR_FACTOR) { /* Un factor común más un shock propio de cada activo */ \
+            const TIPO* cargaComun = p->cargaComun##SUF; \
+            const TIPO* cargaPropia = p->cargaPropia##SUF; \
+            _Pragma("omp simd") \
+            for (int j = 0; j < n; j++) { \
+                x[j] += drift[j] + vol[j] * (cargaComun[j] * factor + cargaPropia[j] * z[j]); \
+            } \
+        } else { /* Shocks correlacionados y = L * z, recorriendo L por columnas: cada y[j] suma en el orden m = 0, 1, ... y el ciclo interno no tiene dependencias */ \
+            for (int j = 0; j < n; j++) { \
+                y[j] = 0; \
+            } \
+            for (int m = 0; m < n; m++) { \
+                const TIPO* columna = p->cholesky##SUF + (size_t)m * n; \
+                TIPO zm = z[m]; \
+                _Pragma("omp simd") \
+                for (int j = m; j < n; j++) { \
+                    y[j] += columna[j] * zm; \
+                } \
+            } \
+            _Pragma("omp simd") \
+            for (int j = 0; j < n; j++) { \
+                x[j] += drift[j] + vol[j] * y[j]; \
+            } \
+        } \
+    } \
+    double perdida = 0; \
+    for (int j = 0; j < n; j++) { \
+        valores[j] = p->valorActual[j] * EXP(x[j]); \
+        perdida += p->valorActual[j] - valores[j]; \
+    } \
+    return perdida; \
+}
+
+// Define un núcleo especializado para una combinación fija de precisión, número de pasos y correlación
+#define DEFINIR_NUCLEO(NOMBRE, SUF, PASOS_MULTIPLES, CORRELACION, ATRIBUTOS) \
+ATRIBUTOS double NOMBRE(const ParametrosNucleo* p, unsigned long long* estado, void* trabajo, double* valores) { \
+    return cuerpoNucleo##SUF(p, PASOS_MULTIPLES, CORRELACION, estado, trabajo, valores); \
+}
+
+// Define los 12 núcleos para un conjunto de instrucciones y su tabla [precisión][pasos][correlacion], constante para que no cambie después de elegir el núcleo
+#define DEFINIR_NUCLEOS_ISA(ISA, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_D_unPaso_identidad, D, 0, CORR_IDENTIDAD, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_D_unPaso_cholesky, D, 0, CORR_CHOLESKY, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_D_unPaso_factor, D, 0, CORR_FACTOR, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_D_variosPasos_identidad, D, 1, CORR_IDENTIDAD, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_D_variosPasos_cholesky, D, 1, CORR_CHOLESKY, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_D_variosPasos_factor, D, 1, CORR_FACTOR, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_F_unPaso_identidad, F, 0, CORR_IDENTIDAD, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_F_unPaso_cholesky, F, 0, CORR_CHOLESKY, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_F_unPaso_factor, F, 0, CORR_FACTOR, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_F_variosPasos_identidad, F, 1, CORR_IDENTIDAD, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_F_variosPasos_cholesky, F, 1, CORR_CHOLESKY, ATRIBUTOS) \
+DEFINIR_NUCLEO(nucleo_##ISA##_F_variosPasos_factor, F, 1, CORR_FACTOR, ATRIBUTOS) \
+static FuncionNucleo const nucleos_##ISA[2][2][3] = { \
+    { { nucleo_##ISA##_D_unPaso_identidad, nucleo_##ISA##_D_unPaso_cholesky, nucleo_##ISA##_D_unPaso_factor }, \
+      { nucleo_##ISA##_D_variosPasos_identidad, nucleo_##ISA##_D_variosPasos_cholesky, nucleo_##ISA##_D_variosPasos_factor } }, \
+    { { nucleo_##ISA##_F_unPaso_identidad, nucleo_##ISA##_F_unPaso_cholesky, nucleo_##ISA##_F_unPaso_factor }, \
+      { nucleo_##ISA##_F_variosPasos_identidad, nucleo_##ISA##_F_variosPasos_cholesky, nucleo_##ISA##_F_variosPasos_factor } } \
+};
+
+DEFINIR_CUERPO_NUCLEO(double, D, generarDistribucionNormalDoble, exp)
+DEFINIR_CUERPO_NUCLEO(float, F, generarDistribucionNormalSimple, expf)
+DEFINIR_NUCLEOS_ISA(generico, )
+#if DESPACHO_ISA
+DEFINIR_NUCLEOS_ISA(avx2fma, __attribute__((target("avx2,fma")))) // Los ciclos omp simd usan registros de 256 bits y FMA
+#endif
+//Los núcleos reemplazan a simularPrecioLogNormal: el precio de cada activo sigue siendo precio_inicial * e^(drift + shock), pero drift y volatilidad * raíz de dt se calculan una sola vez por activo
+//y el horizonte, el número de pasos, la correlación y la precisión ya no se revisan dentro del ciclo de cada activo
+
+
+// Función para clasificar la matriz de correlación
+int clasificarCorrelacion(double** matrizCorrelacion, int numActivos, double* correlacionComun) { // Retorna CORR_IDENTIDAD, CORR_FACTOR si todas las correlaciones son iguales (modelo de un factor) o CORR_CHOLESKY en otro caso
+    int identidad = 1;
+    int factor = 1;
+    *correlacionComun = numActivos > 1 ? matrizCorrelacion[0][1] : 0.0;
+    for (int i = 0; i < numActivos; i++) {
+        for (int j = 0; j < numActivos; j++) {
+            double valor = matrizCorrelacion[i][j];
+            if (i == j) {
+                if (valor != 1.0) {
+                    identidad = 0;
+                    factor = 0;
+                }
+            } else {
+                if (valor != 0.0) {
+                    identidad = 0;
+                }
+                if (valor != *correlacionComun) {
+                    factor = 0;
+                }
+            }
+        }
+    }
+    if (identidad) {
+        return CORR_IDENTIDAD;
+    }
+    if (factor && *correlacionComun > 0.0 && *correlacionComun < 1.0) {
+        return CORR_FACTOR;
+    }
+    return CORR_CHOLESKY;
+}
+
+
+// Función para calcular el factor de Cholesky de la matriz de correlación
+int calcularCholesky(double** matrizCorrelacion, int numActivos, double* cholesky) { // Calcula L triangular inferior con L * L^T = matriz, retorna 0 si la matriz no es definida positiva
+    for (int i = 0; i < numActivos; i++) {
+        for (int j = 0; j <= i; j++) {
+            double suma = matrizCorrelacion[i][j];
+            for (int k = 0; k < j; k++) {
+                suma -= cholesky[(size_t)i * numActivos + k] * cholesky[(size_t)j * numActivos + k];
+            }
+            if (i == j) {
+                if (suma <= 0.0) {
+                    return 0;
+                }
+                cholesky[(size_t)i * numActivos + i] = sqrt(suma);
+            } else {
+                cholesky[(size_t)i * numActivos + j] = suma / cholesky[(size_t)j * numActivos + j];
+            }
+        }
+        for (int j = i + 1; j < numActivos; j++) {
+            cholesky[(size_t)i * numActivos + j] = 0.0;
+        }
+    }
+    return 1;
+}
+
+
+// Función para liberar los parámetros de los núcleos
+void liberarParametrosNucleo(ParametrosNucleo* p) {
+    free(p->valorActual);
+    free(p->driftD);
+    free(p->volD);
+    free(p->choleskyD);
+    free(p->cargaComunD);
+    free(p->cargaPropiaD);
+    free(p->driftF);
+    free(p->volF);
+    free(p->choleskyF);
+    free(p->cargaComunF);
+    free(p->cargaPropiaF);
+}
+
+
+// Función para preparar los parámetros de los núcleos a partir de la cartera
+int prepararParametrosNucleo(Activo* cartera, int numActivos, double** matrizCorrelacion, double horizonte, int numPasos, ParametrosNucleo* p) { // Retorna el tipo de correlación, o -1 si hay un error
+    memset(p, 0, sizeof(ParametrosNucleo));
+    p->numActivos = numActivos;
+    p->numPasos = numPasos;
+
+    for (int i = 0; i < numActivos; i++) { // La volatilidad de cada activo viene de datos.txt, así que la matriz solo puede tener correlaciones; una covarianza con varianzas en la diagonal aplicaría la volatilidad dos veces
+        for (int j = 0; j < numActivos; j++) {
+            double valor = matrizCorrelacion[i][j];
+            if ((i == j && valor != 1.0) || !(valor >= -1.0 && valor <= 1.0) || valor != matrizCorrelacion[j][i]) {
+                printf("La matriz de correlación debe ser simétrica, con 1 en la diagonal y valores entre -1 y 1 (fila %d, columna %d).\n", i + 1, j + 1);
+                return -1;
+            }
+        }
+    }
 
-    double z0 = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2); // Calcula la parte real de un número complejo, usando la fórmula de Box-Muller
-    return z0 * desviacion + media; // Retorna el número aleatorio normalizado, multiplicado por la desviación y sumado a la media
-} // El método Box-Muller es un algoritmo para generar números aleatorios con distribución normal, utilizando dos números aleatorios uniformes entre 0 y 1, y la fórmula de Box-Muller para convertirlos en números con distribución normal con la media y la desviación estándar dadas
+    double correlacionComun;
+    int correlacion = clasificarCorrelacion(matrizCorrelacion, numActivos, &correlacionComun);
+    size_t tamMatriz = (correlacion == CORR_CHOLESKY) ? (size_t)numActivos * numActivos : 1; // Solo el modelo de Cholesky necesita la matriz
+
+    p->valorActual = (double*)malloc(numActivos * sizeof(double));
+    p->driftD = (double*)malloc(numActivos * sizeof(double));
+    p->volD = (double*)malloc(numActivos * sizeof(double));
+    p->choleskyD = (double*)malloc(tamMatriz * sizeof(double));
+    p->cargaComunD = (double*)malloc(numActivos * sizeof(double));
+    p->cargaPropiaD = (double*)malloc(numActivos * sizeof(double));
+    p->driftF = (float*)malloc(numActivos * sizeof(float));
+    p->volF = (float*)malloc(numActivos * sizeof(float));
+    p->choleskyF = (float*)malloc(tamMatriz * sizeof(float));
+    p->cargaComunF = (float*)malloc(numActivos * sizeof(float));
+    p->cargaPropiaF = (float*)malloc(numActivos * sizeof(float));
+    if (!p->valorActual || !p->driftD || !p->volD || !p->choleskyD || !p->cargaComunD || !p->cargaPropiaD ||
+        !p->driftF || !p->volF || !p->choleskyF || !p->cargaComunF || !p->cargaPropiaF) {
+        printf("Error al asignar memoria para los parámetros de simulación.\n");
+        liberarParametrosNucleo(p);
+        return -1;
+    }
 
+    double dt = horizonte / numPasos; // Duración de cada paso
+    for (int j = 0; j < numActivos; j++) {
+        p->valorActual[j] = cartera[j].valor_actual;
+        p->driftD[j] = (cartera[j].tasa_rendimiento - 0.5 * cartera[j].riesgo * cartera[j].riesgo) * dt; // Mismo drift que en la fórmula log-normal, calculado una sola vez
+        p->volD[j] = cartera[j].riesgo * sqrt(dt);
+        p->cargaComunD[j] = sqrt(correlacionComun);
+        p->cargaPropiaD[j] = sqrt(1.0 - correlacionComun);
+        p->driftF[j] = (float)p->driftD[j];
+        p->volF[j] = (float)p->volD[j];
+        p->cargaComunF[j] = (float)p->cargaComunD[j];
+        p->cargaPropiaF[j] = (float)p->cargaPropiaD[j];
+    }
+
+    if (correlacion == CORR_CHOLESKY) {
+        if (!calcularCholesky(matrizCorrelacion, numActivos, p->choleskyD)) {
+            printf("La matriz de correlación no es definida positiva.\n");
+            liberarParametrosNucleo(p);
+            return -1;
+        }
+        for (int i = 0; i < numActivos; i++) { // Transponer: calcularCholesky guarda L por filas y los núcleos la recorren por columnas
+            for (int j = i + 1; j < numActivos; j++) {
+                double temporal = p->choleskyD[(size_t)i * numActivos + j];
+                p->choleskyD[(size_t)i * numActivos + j] = p->choleskyD[(size_t)j * numActivos + i];
+                p->choleskyD[(size_t)j * numActivos + i] = temporal;
+            }
+        }
+        for (size_t k = 0; k < tamMatriz; k++) {
+            p->choleskyF[k] = (float)p->choleskyD[k];
+        }
+    }
+    return correlacion;
+}
 
-// Función para simular precios utilizando distribución log-normal
-double simularPrecioLogNormal(double precio_inicial, double tasa_crecimiento, double volatilidad, double tiempo) { // Simula un precio usando distribución log-normal, con la fórmula de Black-Scholes
-    double drift = (tasa_crecimiento - 0.5 * volatilidad * volatilidad) * tiempo; // Calcula el drift, que es el retorno esperado menos la mitad de la varianza, multiplicado por el tiempo
-    double shock = volatilidad * sqrt(tiempo) * generarDistribucionNormal(0, 1); // Calcula el shock, que es la volatilidad multiplicada por la raíz cuadrada del tiempo, multiplicado por un número aleatorio normal
-    return precio_inicial * exp(drift + shock); // Retorna el precio simulado, que es el precio inicial multiplicado por e^(drift + shock)
-} //Drift es el retorno esperado menos la mitad de la varianza, multiplicado por el tiempo
-//Shock es la volatilidad multiplicada por la raíz cuadrada del tiempo, multiplicado por un número aleatorio normal
-//La distribución log-normal es una distribución de probabilidad continua que se utiliza para modelar precios de activos financieros, donde los retornos se asumen como log-normales, lo que significa que los precios futuros se calculan como el precio actual multiplicado por e^(drift + shock)
 
+// Función para elegir el núcleo de simulación
+FuncionNucleo seleccionarNucleo(int precisionSimple, int numPasos, int correlacion) { // Se llama una vez al inicio, elige el núcleo según la configuración de la simulación y las instrucciones que soporta el procesador
+    const char* nombresCorrelacion[] = { "identidad", "Cholesky", "un factor" };
+    FuncionNucleo const (*tabla)[2][3] = nucleos_generico;
+    const char* isa = "genérico";
+#if DESPACHO_ISA
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        tabla = nucleos_avx2fma;
+        isa = "AVX2+FMA";
+    }
+#endif
+    printf("Núcleo de simulación: %s, %s, correlación %s, %s\n", precisionSimple ? "float" : "double", numPasos > 1 ? "varios pasos" : "un paso", nombresCorrelacion[correlacion], isa);
+    return tabla[precisionSimple ? 1 : 0][numPasos > 1 ? 1 : 0][correlacion];
+} // Con FMA los últimos dígitos pueden diferir de los del núcleo genérico; la versión secuencial y la paralela eligen el mismo núcleo en la misma máquina, así que sus reportes siguen siendo idénticos
 
-// Función para generar una matriz de covarianza (en este ejemplo, se usa una identidad simple)
-double** generarMatrizCovarianza(int numActivos) { // Genera una matriz de covarianza simple, que es una matriz identidad simple (1 en la diagonal, 0 en otros lugares)
+
+// Función para generar una matriz de correlación (en este ejemplo, se usa una identidad simple)
+double** generarMatrizCorrelacion(int numActivos) { // Genera una matriz de correlación simple, que es una matriz identidad simple (1 en la diagonal, 0 en otros lugares)
     double** matriz = (double**)malloc(numActivos * sizeof(double*)); // Asigna memoria para la matriz, que es un array de arrays
     #pragma omp parallel for schedule(dynamic) // Paraleliza el ciclo para asignar memoria a cada fila de la matriz
     for (int i = 0; i < numActivos; i++) { //
@@ -85,25 +398,261 @@ double** generarMatrizCovarianza(int numActivos) { // Genera una matriz de covar
     return matriz; 
 }
 
+// Función para leer la configuración opcional de la simulación
+int leerConfiguracion(const char* nombreArchivo, int numActivos, double* horizonte, int* numPasos, int* precisionSimple, double** matrizCorrelacion) { // Cambia los valores por defecto según el archivo, retorna 0 si el archivo tiene un error
+    FILE* archivo = fopen(nombreArchivo, "r");
+    if (!archivo) {
+        if (errno == ENOENT) { // El archivo es opcional, sin él se usan los valores por defecto
+            return 1;
+        }
+        printf("No se pudo abrir el archivo de configuración: %s\n", nombreArchivo);
+        return 0;
+    }
+
+    char clave[50];
+    char valor[50];
+    int valido = 1;
+    while (valido && fscanf(archivo, "%49s", clave) == 1) { // Cada opción es una palabra clave seguida de su valor
+        if (strcmp(clave, "pasos") == 0) {
+            valido = fscanf(archivo, "%d", numPasos) == 1 && *numPasos >= 1;
+        } else if (strcmp(clave, "horizonte") == 0) {
+            valido = fscanf(archivo, "%lf", horizonte) == 1 && *horizonte > 0 && isfinite(*horizonte);
+        } else if (strcmp(clave, "precision") == 0) {
+            valido = fscanf(archivo, "%49s", valor) == 1 && (strcmp(valor, "float") == 0 || strcmp(valor, "double") == 0);
+            if (valido) {
+                *precisionSimple = strcmp(valor, "float") == 0;
+            }
+        } else if (strcmp(clave, "correlacion") == 0) {
+            valido = fscanf(archivo, "%49s", valor) == 1;
+            if (valido && strcmp(valor, "identidad") == 0) { // Activos independientes, es la matriz por defecto
+                for (int i = 0; i < numActivos; i++) {
+                    for (int j = 0; j < numActivos; j++) {
+                        matrizCorrelacion[i][j] = (i == j) ? 1.0 : 0.0;
+                    }
+                }
+            } else if (valido && strcmp(valor, "constante") == 0) { // Misma correlación entre todos los pares de activos
+                double rho;
+                valido = fscanf(archivo, "%lf", &rho) == 1;
+                for (int i = 0; valido && i < numActivos; i++) {
+                    for (int j = 0; j < numActivos; j++) {
+                        matrizCorrelacion[i][j] = (i == j) ? 1.0 : rho;
+                    }
+                }
+            } else if (valido && strcmp(valor, "matriz") == 0) { // Matriz completa, numActivos x numActivos valores
+                for (int i = 0; valido && i < numActivos; i++) {
+                    for (int j = 0; valido && j < numActivos; j++) {
+                        valido = fscanf(archivo, "%lf", &matrizCorrelacion[i][j]) == 1;
+                    }
+                }
+            } else {
+                valido = 0;
+            }
+        } else {
+            valido = 0;
+        }
+        if (!valido) {
+            printf("Error en %s: opción '%s' desconocida o con un valor inválido.\n", nombreArchivo, clave);
+        }
+    }
+
+    fclose(archivo);
+    return valido; // La matriz de correlación se valida después, en prepararParametrosNucleo
+}
+
+
 
 // Función para simular escenarios con correlación entre activos
-double* simularEscenariosCorrelacionadosParalelizado(Activo* cartera, int numActivos, int numEscenarios, double** matrizCovarianza) { // Simula escenarios con correlación entre activos
-    double* perdidas = (double*)malloc(numEscenarios * sizeof(double)); //Usa la matriz de covarianza para simular escenarios con correlación entre activos, donde las pérdidas se calculan para cada escenario
-    #pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < numEscenarios; i++) {
-        printf("Simulación %d:\n", i + 1);
-        perdidas[i] = 0; // Inicializar pérdidas del escenario
-        for (int j = 0; j < numActivos; j++) {
-            double nuevo_valor = simularPrecioLogNormal(cartera[j].valor_actual, cartera[j].tasa_rendimiento, cartera[j].riesgo, 1); // Simular el precio del activo
-            perdidas[i] += cartera[j].valor_actual - nuevo_valor; // Calcular la pérdida del activo
-            printf("  Activo: %s, Valor ajustado: %.2f\n", cartera[j].nombre, nuevo_valor); // Imprimir el valor ajustado del activo
+double* simularEscenariosCorrelacionadosParalelizado(Activo* cartera, int numActivos, int numEscenarios, const ParametrosNucleo* parametros, FuncionNucleo nucleo) { // Simula escenarios con correlación entre activos usando el núcleo elegido por seleccionarNucleo
+    double* perdidas = (double*)malloc(numEscenarios * sizeof(double)); //Usa la matriz de correlación para simular escenarios con correlación entre activos, donde las pérdidas se calculan para cada escenario
+    if (perdidas == NULL) {
+        printf("Error al asignar memoria para la simulación.\n");
+        return NULL;
+    }
+    int errorMemoria = 0;
+    #pragma omp parallel
+    {
+        double* trabajo = (double*)malloc(3 * numActivos * sizeof(double)); // Espacio de trabajo del núcleo, propio de cada hilo
+        double* valores = (double*)malloc(numActivos * sizeof(double)); // Valores ajustados del escenario, propios de cada hilo
+        if (trabajo == NULL || valores == NULL) {
+            #pragma omp atomic write
+            errorMemoria = 1;
+        }
+        #pragma omp barrier // Todos los hilos ven el mismo errorMemoria, así todos entran o ninguno entra al ciclo
+        if (!errorMemoria) {
+            #pragma omp for schedule(dynamic)
+            for (int i = 0; i < numEscenarios; i++) {
+                printf("Simulación %d:\n", i + 1);
+                unsigned long long estado = SEMILLA ^ ((unsigned long long)i * 0xD1B54A32D192ED03ULL); // Estado aleatorio propio del escenario, depende solo de la semilla y del número de escenario
+                perdidas[i] = nucleo(parametros, &estado, trabajo, valores); // Simular los precios de todos los activos y calcular la pérdida del escenario
+                for (int j = 0; j < numActivos; j++) {
+                    printf("  Activo: %s, Valor ajustado: %.2f\n", cartera[j].nombre, valores[j]); // Imprimir el valor ajustado del activo
+                }
+            }
         }
+        free(trabajo);
+        free(valores);
+    }
+    if (errorMemoria) {
+        printf("Error al asignar memoria para la simulación.\n");
+        free(perdidas);
+        return NULL;
     }
     return perdidas; // Retornar pérdidas simuladas
 } //Simula el precio del activo, con la fórmula de Black-Scholes
 //La fórmula de Black-Scholes es una fórmula matemática que se utiliza para calcular el precio de las opciones financieras, basándose en la volatilidad del activo subyacente, el tiempo hasta la expiración de la opción, el precio de ejercicio de la opción y la tasa de interés libre de riesgo.
 
 
+// Función para leer un escenario (una fila) del archivo de escenarios
+int leerEscenario(FILE* archivo, double* rendimientos, int numActivos, int* fila) { // Retorna 1 si leyó la fila completa, 0 al llegar al fin del archivo y -1 si la fila está incompleta o tiene datos inválidos
+    int c = getc(archivo);
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n') { // Saltar espacios y filas vacías, contando las filas
+        if (c == '\n') {
+            (*fila)++;
+        }
+        c = getc(archivo);
+    }
+    if (c == EOF) {
+        return 0;
+    }
+    ungetc(c, archivo);
+
+    for (int j = 0; j < numActivos; j++) {
+        if (j > 0) { // Los rendimientos de un escenario deben estar en la misma fila, fscanf por sí solo saltaría al siguiente renglón
+            c = getc(archivo);
+            while (c == ' ' || c == '\t' || c == '\r') {
+                c = getc(archivo);
+            }
+            if (c == '\n' || c == EOF) {
+                return -1; // Fila con menos rendimientos que activos
+            }
+            ungetc(c, archivo);
+        }
+        if (fscanf(archivo, "%lf", &rendimientos[j]) != 1 || !isfinite(rendimientos[j])) {
+            return -1; // Dato que no es un número
+        }
+    }
+
+    c = getc(archivo); // Después del último rendimiento solo puede terminar la fila
+    while (c == ' ' || c == '\t' || c == '\r') {
+        c = getc(archivo);
+    }
+    if (c == '\n') {
+        ungetc(c, archivo); // El salto de línea se cuenta en la siguiente llamada
+    } else if (c != EOF) {
+        return -1; // Fila con más rendimientos que activos o con datos extra
+    }
+    return 1;
+}
+
+
+// Función para simular escenarios históricos o de estrés leídos desde un archivo
+double* simularEscenariosHistoricosParalelizado(Activo* cartera, int numActivos, const char* nombreArchivo, int* numEscenarios) { // Aplica a la cartera vectores de rendimientos (uno por activo en cada escenario) leídos por bloques, para no cargar todo el historial en memoria
+    *numEscenarios = -1; // Se queda en -1 si el archivo existe pero no se puede usar, así main distingue un error de un archivo ausente
+    FILE* archivo = fopen(nombreArchivo, "r");
+    if (!archivo) {
+        if (errno == ENOENT) { // El archivo de escenarios es opcional, si no existe no se hace la simulación histórica
+            *numEscenarios = 0;
+        } else {
+            printf("No se pudo abrir el archivo de escenarios: %s\n", nombreArchivo);
+        }
+        return NULL;
+    }
+
+    int activosArchivo; // El archivo indica en su primera fila cuántos rendimientos tiene cada escenario
+    if (fscanf(archivo, "%d", &activosArchivo) != 1 || activosArchivo != numActivos) {
+        printf("El archivo de escenarios no corresponde a los %d activos de la cartera.\n", numActivos);
+        fclose(archivo);
+        return NULL;
+    }
+
+    if (numActivos < 1) { // Sin activos no hay rendimientos que aplicar
+        printf("La cartera no tiene activos, no se realiza la simulación histórica.\n");
+        fclose(archivo);
+        return NULL;
+    }
+
+    int escenariosPorBloque = MAX_VALORES_BLOQUE / numActivos; // Número de escenarios que caben en un bloque, así la memoria usada no depende del largo del historial
+    if (escenariosPorBloque < 1) {
+        escenariosPorBloque = 1;
+    }
+    double* bloque = (double*)malloc((size_t)escenariosPorBloque * numActivos * sizeof(double)); // Rendimientos del bloque actual, escenario por escenario
+    size_t capacidad = escenariosPorBloque; // Capacidad del array de pérdidas, crece conforme se leen más bloques
+    double* perdidas = (double*)malloc(capacidad * sizeof(double));
+    if (bloque == NULL || perdidas == NULL) {
+        printf("Error al asignar memoria para los escenarios.\n");
+        free(bloque);
+        free(perdidas);
+        fclose(archivo);
+        return NULL;
+    }
+
+    int leidosTotal = 0;
+    int fila = 1; // Fila del archivo que se está leyendo, la primera tiene el número de activos
+    int fin = 0;
+    while (!fin) {
+        // Leer el siguiente bloque de escenarios completos
+        int leidos = 0;
+        while (leidos < escenariosPorBloque) {
+            int resultado = leerEscenario(archivo, bloque + (size_t)leidos * numActivos, numActivos, &fila);
+            if (resultado == 0) {
+                fin = 1;
+                break;
+            }
+            if (resultado < 0 || leidosTotal + leidos == INT_MAX) { // Un escenario que no se puede leer invalida toda la simulación histórica, no se reporta un resultado parcial
+                printf("Escenario %d (fila %d de %s) incompleto o inválido, no se realiza la simulación histórica.\n", leidosTotal + leidos + 1, fila, nombreArchivo);
+                free(bloque);
+                free(perdidas);
+                fclose(archivo);
+                return NULL;
+            }
+            leidos++;
+        }
+        if (leidos == 0) {
+            break;
+        }
+
+        if ((size_t)leidosTotal + leidos > capacidad) { // Ampliar el array de pérdidas si el bloque no cabe
+            while ((size_t)leidosTotal + leidos > capacidad) {
+                capacidad *= 2;
+            }
+            double* ampliadas = (double*)realloc(perdidas, capacidad * sizeof(double));
+            if (ampliadas == NULL) {
+                printf("Error al asignar memoria para las pérdidas históricas.\n");
+                free(bloque);
+                free(perdidas);
+                fclose(archivo);
+                return NULL;
+            }
+            perdidas = ampliadas;
+        }
+
+        // Aplicar cada escenario del bloque a la cartera
+        double* perdidasBloque = perdidas + leidosTotal;
+        #pragma omp parallel for schedule(static) // Los escenarios del bloque son independientes entre sí
+        for (int i = 0; i < leidos; i++) {
+            const double* rendimientos = bloque + (size_t)i * numActivos;
+            double perdida = 0;
+            for (int j = 0; j < numActivos; j++) {
+                perdida -= cartera[j].valor_actual * rendimientos[j]; // La pérdida del activo es el valor actual por el rendimiento del escenario, con signo contrario
+            }
+            perdidasBloque[i] = perdida;
+        }
+        leidosTotal += leidos;
+    }
+
+    free(bloque);
+    fclose(archivo);
+    if (leidosTotal == 0) {
+        printf("El archivo de escenarios no contiene escenarios válidos.\n");
+        free(perdidas);
+        return NULL;
+    }
+    *numEscenarios = leidosTotal;
+    return perdidas; // Retornar pérdidas históricas, una por escenario del archivo
+} // La simulación histórica no supone ninguna distribución: las pérdidas salen directamente de los rendimientos observados (o definidos por el usuario para pruebas de estrés)
+
+
+
 // Función para validar los datos de los activos
 int validarDatosParalelizado(Activo* cartera, int numActivos) { // Valida que los datos sean válidos
     int datosValidos = 1; // Variable para indicar si los datos son válidos o no
@@ -132,30 +681,79 @@ int comparar(const void* a, const void* b) { // Compara dos valores para ordenar
 
 // Función para calcular el VaR utilizando percentiles
 double calcularVaRPercentil(double* perdidas, int numEscenarios, double confianza) { // Calcula el VaR de acuerdo a un percentil dado, que es la pérdida máxima esperada con un nivel de confianza dado (por ejemplo, 95%), utilizando la función qsort
-    int indice = (int)(numEscenarios * (1 - confianza)); // Calcula el índice del percentil, que es el número de escenarios multiplicado por el complemento de la confianza
+    int indice = (int)(numEscenarios * confianza); // Calcula el índice del percentil, que es el número de escenarios multiplicado por la confianza: las pérdidas están ordenadas de menor a mayor, así que el VaR es la pérdida que solo se supera en el (1 - confianza) de los escenarios
+    if (indice >= numEscenarios) {
+        indice = numEscenarios - 1;
+    }
     qsort(perdidas, numEscenarios, sizeof(double), comparar); // Ordena las pérdidas de menor a mayor, utilizando la función de comparación dada
     return perdidas[indice]; // Retorna el VaR, que es la pérdida en el percentil dado
 } //qsort ordena las pérdidas de menor a mayor, utilizando la función de comparación dada, que compara dos valores para ordenarlos, necesario para qsort, que ordena un array de acuerdo a una función de comparación dada (en este caso, para ordenar las pérdidas)
 
 
+// Función para sumar un bloque con suma compensada de Kahan
+double sumarBloqueKahan(double* datos, int inicio, int fin, double media, int alCuadrado) { // Suma datos[inicio..fin), o (dato - media)^2 si alCuadrado es 1, acumulando el error de redondeo para corregirlo
+    double suma = 0.0;
+    double compensacion = 0.0; // Error de redondeo acumulado, se resta en la siguiente suma
+    for (int i = inicio; i < fin; i++) {
+        double valor = alCuadrado ? (datos[i] - media) * (datos[i] - media) : datos[i];
+        double y = valor - compensacion;
+        double t = suma + y;
+        compensacion = (t - suma) - y;
+        suma = t;
+    }
+    return suma;
+}
+
+
+// Función para sumar un array de forma reproducible
+double sumarReproducible(double* datos, int numDatos, double media, int alCuadrado) { // Divide los datos en bloques cuyo tamaño depende solo de numDatos, los suma con Kahan y combina los resultados en un árbol fijo, el orden de las operaciones es siempre el mismo
+    double parciales[MAX_BLOQUES_SUMA]; // Suma de cada bloque, sin memoria dinámica para que no haya un camino alterno con otro orden de suma
+    size_t tamBloque = TAM_BLOQUE_SUMA;
+    if ((size_t)numDatos > tamBloque * MAX_BLOQUES_SUMA) { // Con muchos datos los bloques son más grandes, el tamaño depende solo de numDatos
+        tamBloque = ((size_t)numDatos + MAX_BLOQUES_SUMA - 1) / MAX_BLOQUES_SUMA;
+    }
+    int numBloques = (int)(((size_t)numDatos + tamBloque - 1) / tamBloque);
+    #pragma omp parallel for schedule(static) // Cada bloque se suma por separado, el resultado de cada bloque no depende del hilo
+    for (int b = 0; b < numBloques; b++) {
+        size_t inicio = (size_t)b * tamBloque;
+        size_t fin = inicio + tamBloque < (size_t)numDatos ? inicio + tamBloque : (size_t)numDatos;
+        parciales[b] = sumarBloqueKahan(datos, (int)inicio, (int)fin, media, alCuadrado);
+    }
+    for (int paso = 1; paso < numBloques; paso *= 2) { // Suma por pares: 0+1, 2+3, ... luego 0+2, 4+6, ... hasta dejar el total en parciales[0]
+        for (int b = 0; b + paso < numBloques; b += 2 * paso) {
+            parciales[b] += parciales[b + paso];
+        }
+    }
+    return numBloques > 0 ? parciales[0] : 0.0;
+} // Con reduction(+) cada hilo suma una parte distinta según cuántos hilos haya, y como la suma de doubles no es asociativa los últimos dígitos cambian. Aquí la partición depende solo de numDatos
+
+
 // Función para calcular la media de un array
 double calcularMedia(double* datos, int numDatos) { // Calcula la media de un array de datos, que es la suma de los datos dividida por el número de datos
+#if MODO_REPRODUCIBLE
+    double suma = sumarReproducible(datos, numDatos, 0.0, 0); // Suma idéntica con cualquier número de hilos
+#else
     double suma = 0.0; // Inicializa la suma en 0, luego suma todos los datos
     #pragma omp parallel for reduction(+:suma) // Paraleliza el ciclo y suma los resultados de cada hilo
     for (int i = 0; i < numDatos; i++) {
         suma += datos[i]; 
     }
+#endif
     return suma / numDatos; 
 }
 
 
 // Función para calcular la desviación eOk stándar de un array
 double calcularDesviacionEstandar(double* datos, int numDatos, double media) { // Calcula la desviación estándar de un array de datos, que es la raíz cuadrada de la varianza
+#if MODO_REPRODUCIBLE
+    double suma = sumarReproducible(datos, numDatos, media, 1); // Suma de las diferencias al cuadrado, idéntica con cualquier número de hilos
+#else
     double suma = 0.0; // Inicializa la suma en 0, luego suma la diferencia al cuadrado entre cada dato y la media
     #pragma omp parallel for reduction(+:suma) // Paraleliza el ciclo y suma los resultados de cada hilo
     for (int i = 0; i < numDatos; i++) {
         suma += pow(datos[i] - media, 2); // Suma la diferencia al cuadrado entre cada dato y la media
     }
+#endif
     return sqrt(suma / numDatos); // Retorna la raíz cuadrada de la varianza, que es la suma de la diferencia al cuadrado entre cada dato y la media, dividida por el número de datos
 } //pow es una función que calcula la potencia de un número, en este caso, la diferencia entre el dato y la media, elevada al cuadrado
 
@@ -204,7 +802,6 @@ void generarReporte(Activo* cartera, int numActivos, int numEscenarios, double*
 
     // Resumen por Activo
     fprintf(reporte, "Resumen por Activo:\n");
-    #pragma omp parallel ordered
     for (int i = 0; i < numActivos; i++) {
         fprintf(reporte, "Activo: %s\n", cartera[i].nombre);
         fprintf(reporte, "  Valor Inicial: %.2f\n", cartera[i].valor_actual);
@@ -245,6 +842,43 @@ void generarReporte(Activo* cartera, int numActivos, int numEscenarios, double*
 }
 
 
+// Función para agregar al reporte los resultados de la simulación histórica y de estrés
+void generarReporteHistorico(int numEscenarios, double* perdidas, double var, double peorPerdida, int peorEscenario) {
+    FILE *reporte = fopen("reporte_final.txt", "a"); // Se agrega al final del reporte generado por la simulación Monte Carlo
+    if (reporte == NULL) {
+        printf("Error al abrir el archivo para escribir el reporte histórico.\n");
+        return;
+    }
+
+    fprintf(reporte, "--- Simulación Histórica y Pruebas de Estrés ---\n");
+    fprintf(reporte, "Número de Escenarios Históricos: %d\n\n", numEscenarios);
+
+    // VaR histórico
+    fprintf(reporte, "Valor en Riesgo (VaR) histórico al 95%% de confianza: %.2f\n", var);
+    fprintf(reporte, "Interpretación: Este VaR se obtiene directamente de los rendimientos del archivo de escenarios, sin suponer una distribución log-normal.\n\n");
+
+    // Media y desviación estándar de las pérdidas históricas
+    double mediaPerdidas = calcularMedia(perdidas, numEscenarios);
+    fprintf(reporte, "Media de las Pérdidas Históricas: %.2f\n", mediaPerdidas);
+    double desviacionEstandarPerdidas = calcularDesviacionEstandar(perdidas, numEscenarios, mediaPerdidas);
+    fprintf(reporte, "Desviación Estándar de las Pérdidas Históricas: %.2f\n\n", desviacionEstandarPerdidas);
+
+    // Peor escenario (prueba de estrés)
+    fprintf(reporte, "Pérdida en el Peor Escenario: %.2f (escenario %d)\n", peorPerdida, peorEscenario);
+    fprintf(reporte, "Interpretación: Es la pérdida que tendría la cartera si se repitiera el escenario más adverso del archivo.\n");
+    if (var <= 0) {
+        fprintf(reporte, "Comentario: El VaR histórico no es una pérdida, en el 95%% de los escenarios la cartera no pierde valor. El peor escenario indica la pérdida máxima observada.\n\n");
+    } else if (peorPerdida > 2 * var) {
+        fprintf(reporte, "Comentario: La pérdida de estrés supera ampliamente al VaR, la cartera es sensible a eventos extremos.\n\n");
+    } else {
+        fprintf(reporte, "Comentario: La pérdida de estrés es cercana al VaR, los eventos extremos no se alejan mucho de las condiciones normales.\n\n");
+    }
+
+    fclose(reporte);
+    printf("Resultados históricos agregados a 'reporte_final.txt'.\n");
+}
+
+
    
 
 
@@ -253,6 +887,8 @@ int main() {
     Activo* cartera;
     int numActivos;
     const char* nombreArchivo = "datos.txt";
+    const char* nombreArchivoEscenarios = "escenarios.txt";
+    const char* nombreArchivoConfiguracion = "configuracion.txt";
 
     printf("Simulación Financiera\n");
     printf("Este programa simula escenarios financieros y calcula el Valor en Riesgo (VaR) de una cartera de activos.\n\n");
@@ -266,6 +902,14 @@ int main() {
     printf("Activo2 25000.00 0.07 0.03\n");
     printf("Activo3 18000.00 0.06 0.025\n");
     printf("Activo4 22000.00 0.08 0.04\n\n");
+    printf("Opcionalmente, cree un archivo 'escenarios.txt' para la simulación histórica y las pruebas de estrés:\n");
+    printf("Número de activos en la primera fila, luego una fila por escenario con el rendimiento de cada activo (por ejemplo -0.05 para una caída del 5%%)\n\n");
+    printf("Opcionalmente, cree un archivo 'configuracion.txt' para elegir el modelo de simulación, con una opción por fila:\n");
+    printf("pasos 12                  (pasos en que se divide el horizonte, por defecto 1)\n");
+    printf("horizonte 1.0             (horizonte de la simulación en años, por defecto 1.0)\n");
+    printf("precision float           (float o double, por defecto double)\n");
+    printf("correlacion constante 0.3 (misma correlación entre todos los activos, por defecto identidad)\n");
+    printf("correlacion matriz        (seguido de la matriz de correlación completa, número de activos x número de activos, con 1 en la diagonal)\n\n");
     printf("Presione cualquier tecla para continuar\n\n");
     getchar();
 
@@ -282,8 +926,27 @@ int main() {
         return 1;
     }
 
-    // Definir la matriz de covarianza
-    double** matrizCovarianza = generarMatrizCovarianza(numActivos);
+    // Definir la matriz de correlación
+    double** matrizCorrelacion = generarMatrizCorrelacion(numActivos);
+
+    // Configuración de los núcleos de simulación, los valores por defecto se pueden cambiar en configuracion.txt
+    double horizonte = 1.0; // Horizonte de la simulación, en años
+    int numPasos = 1; // Pasos en que se divide el horizonte, con 1 se usa el núcleo de un solo paso
+    int precisionSimple = 0; // 1 para simular en float, 0 para double
+    ParametrosNucleo parametros;
+    int correlacion = -1;
+    if (leerConfiguracion(nombreArchivoConfiguracion, numActivos, &horizonte, &numPasos, &precisionSimple, matrizCorrelacion)) {
+        correlacion = prepararParametrosNucleo(cartera, numActivos, matrizCorrelacion, horizonte, numPasos, &parametros); // Valida y clasifica la matriz de correlación y calcula una sola vez los datos de cada activo
+    }
+    if (correlacion < 0) {
+        free(cartera);
+        for (int i = 0; i < numActivos; i++) {
+            free(matrizCorrelacion[i]);
+        }
+        free(matrizCorrelacion);
+        return 1;
+    }
+    FuncionNucleo nucleo = seleccionarNucleo(precisionSimple, numPasos, correlacion); // Elige el núcleo especializado una sola vez, antes de simular
 
     // Simulación de escenarios
     int numEscenarios = 1000;
@@ -292,8 +955,16 @@ int main() {
    
 
     // Generar pérdidas simuladas para calcular VaR
-    double* perdidas = simularEscenariosCorrelacionadosParalelizado(cartera, numActivos, numEscenarios, matrizCovarianza);
-
+    double* perdidas = simularEscenariosCorrelacionadosParalelizado(cartera, numActivos, numEscenarios, &parametros, nucleo);
+    if (perdidas == NULL) {
+        liberarParametrosNucleo(&parametros);
+        free(cartera);
+        for (int i = 0; i < numActivos; i++) {
+            free(matrizCorrelacion[i]);
+        }
+        free(matrizCorrelacion);
+        return 1;
+    }
 
     // Cálculo del VaR
     double var = calcularVaRPercentil(perdidas, numEscenarios, 0.95);
@@ -301,16 +972,36 @@ int main() {
     // Generar el reporte final
     generarReporte(cartera, numActivos, numEscenarios, perdidas, var);
 
+    // Simulación histórica y de estrés, solo si existe el archivo de escenarios
+    int numEscenariosHistoricos = 0;
+    int codigoSalida = 0;
+    double* perdidasHistoricas = simularEscenariosHistoricosParalelizado(cartera, numActivos, nombreArchivoEscenarios, &numEscenariosHistoricos);
+    if (perdidasHistoricas != NULL) {
+        int peorEscenario = 0; // Se busca antes de calcular el VaR, porque el cálculo ordena las pérdidas
+        for (int i = 1; i < numEscenariosHistoricos; i++) {
+            if (perdidasHistoricas[i] > perdidasHistoricas[peorEscenario]) {
+                peorEscenario = i;
+            }
+        }
+        double peorPerdida = perdidasHistoricas[peorEscenario];
+        double varHistorico = calcularVaRPercentil(perdidasHistoricas, numEscenariosHistoricos, 0.95); // Mismo cálculo que el VaR Monte Carlo, así ambos se pueden comparar
+        generarReporteHistorico(numEscenariosHistoricos, perdidasHistoricas, varHistorico, peorPerdida, peorEscenario + 1);
+        free(perdidasHistoricas);
+    } else if (numEscenariosHistoricos < 0) { // El archivo existe pero no se pudo usar, el programa termina con error aunque el reporte Monte Carlo ya se generó
+        codigoSalida = 1;
+    }
+
     // Liberar memoria
     free(cartera);
     for (int i = 0; i < numActivos; i++) {
-        free(matrizCovarianza[i]);
+        free(matrizCorrelacion[i]);
     }
-    free(matrizCovarianza);
+    free(matrizCorrelacion);
     free(perdidas);
+    liberarParametrosNucleo(&parametros);
 
     double end_time = omp_get_wtime();
     printf("Tiempo total de ejecución: %.2f segundos\n", end_time - start_time);
 
-    return 0;
+    return codigoSalida;
 }
\ No newline at end of file